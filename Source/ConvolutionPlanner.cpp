@@ -0,0 +1,99 @@
+#include "ConvolutionPlanner.h"
+
+namespace
+{
+    // Cost of one tap per output sample in the same units as realFftOps: the chunked multiply-add loop
+    // measured ~0.85 ns per tap-sample against ~0.77 nominal FFT flops per ns for the fallback FFT
+    constexpr double directOpsPerTap = 0.65;
+    constexpr double complexMultiplyOps = 6.0;
+    constexpr int minPartitionSize = 64;
+    constexpr int maxPartitionSize = 1 << 20;
+    constexpr int maxFftOrder = 30;
+
+    double realFftOps(double size)
+    {
+        return 2.5 * size * std::log2(size);
+    }
+
+    int64_t nextPowerOfTwo(int64_t n)
+    {
+        int64_t size = 1;
+        while (size < n)
+            size <<= 1;
+        return size;
+    }
+}
+
+int64_t ConvolutionPlan::getDefaultMemoryBudget()
+{
+    // Half of total physical memory, not free memory (JUCE doesn't report that);
+    // callers subtract whatever they already hold before passing it to choose()
+    return static_cast<int64_t>(juce::SystemStats::getMemorySizeInMegabytes()) * 1024 * 1024 / 2;
+}
+
+ConvolutionPlan ConvolutionPlan::choose(int64_t lenA, int64_t lenB, int numChannels, int64_t memoryBudgetBytes)
+{
+    auto filterLen = std::min(lenA, lenB);
+    auto signalLen = std::max(lenA, lenB);
+    auto convLen = lenA + lenB - 1;
+    auto channels = static_cast<double>(numChannels);
+
+    ConvolutionPlan best;
+    best.algorithm = Algorithm::Direct;
+    best.estimatedOps = directOpsPerTap * static_cast<double>(filterLen) * static_cast<double>(signalLen) * channels;
+
+    // One transform of the full padded length, channels processed one at a time
+    auto fftSize = nextPowerOfTwo(convLen);
+    auto fftBytes = fftSize * 2 * 2 * static_cast<int64_t>(sizeof(float));
+    if (fftSize <= (int64_t(1) << maxFftOrder) && fftBytes <= memoryBudgetBytes)
+    {
+        auto n = static_cast<double>(fftSize);
+        auto ops = channels * (3.0 * realFftOps(n) + complexMultiplyOps * n / 2.0);
+
+        if (ops < best.estimatedOps)
+        {
+            best.algorithm = Algorithm::SingleFFT;
+            best.estimatedOps = ops;
+            best.estimatedBytes = fftBytes;
+        }
+    }
+
+    // Uniform partitions: bigger blocks mean fewer transforms per sample but more partitions to accumulate
+    auto largestPartition = std::min<int64_t>(maxPartitionSize, nextPowerOfTwo(filterLen));
+    for (int64_t size = minPartitionSize; size <= std::max<int64_t>(minPartitionSize, largestPartition); size <<= 1)
+    {
+        auto numPartitions = (filterLen + size - 1) / size;
+        auto numBlocks = (convLen + size - 1) / size;
+        auto bins = static_cast<double>(size + 1);
+        auto bytes = 2 * static_cast<int64_t>(numChannels) * numPartitions * 2 * (size + 1) * static_cast<int64_t>(sizeof(float));
+
+        if (bytes > memoryBudgetBytes)
+            continue;
+
+        auto perBlock = 2.0 * realFftOps(2.0 * size) + complexMultiplyOps * bins * static_cast<double>(numPartitions);
+        auto ops = channels * (static_cast<double>(numBlocks) * perBlock
+                               + static_cast<double>(numPartitions) * realFftOps(2.0 * size));
+
+        if (ops < best.estimatedOps)
+        {
+            best.algorithm = Algorithm::Partitioned;
+            best.partitionSize = static_cast<int>(size);
+            best.estimatedOps = ops;
+            best.estimatedBytes = bytes;
+        }
+    }
+
+    return best;
+}
+
+juce::String ConvolutionPlan::describe() const
+{
+    switch (algorithm)
+    {
+        case Algorithm::Direct:      return "direct";
+        case Algorithm::Partitioned: return "partitioned, " + juce::String(partitionSize) + "-sample blocks";
+        case Algorithm::SingleFFT:   return "single FFT";
+    }
+
+    return {};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Picks the cheapest offline convolution strategy for a job's shape and memory budget.
+struct ConvolutionPlan
+{
+    enum class Algorithm { Direct, Partitioned, SingleFFT };
+
+    // Lengths are interchangeable; the shorter input always plays the role of the filter.
+    static ConvolutionPlan choose(int64_t lenA, int64_t lenB, int numChannels, int64_t memoryBudgetBytes);
+    static int64_t getDefaultMemoryBudget();
+
+    juce::String describe() const;
+
+    Algorithm algorithm = Algorithm::SingleFFT;
+    int partitionSize = 0;          // Partitioned only
+    double estimatedOps = 0.0;      // rough floating point operation count
+    int64_t estimatedBytes = 0;     // working memory on top of the input and output buffers
+};
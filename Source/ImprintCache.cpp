@@ -0,0 +1,122 @@
+#include "ImprintCache.h"
+#include "ImprintResampler.h"
+
+namespace
+{
+    juce::AudioBuffer<float> trimSilence(const juce::AudioBuffer<float>& buffer)
+    {
+        auto threshold = juce::Decibels::decibelsToGain(-80.0f);
+        auto numSamples = buffer.getNumSamples();
+        int first = numSamples, last = -1;
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* data = buffer.getReadPointer(ch);
+            for (int i = 0; i < numSamples; ++i)
+            {
+                if (std::abs(data[i]) > threshold)
+                {
+                    first = std::min(first, i);
+                    last = std::max(last, i);
+                }
+            }
+        }
+
+        if (last < first)
+            return {};
+
+        juce::AudioBuffer<float> trimmed(buffer.getNumChannels(), last - first + 1);
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            trimmed.copyFrom(ch, 0, buffer, ch, first, trimmed.getNumSamples());
+
+        return trimmed;
+    }
+
+    // Unit energy on the loudest channel, applied per rate so every variant plays at the same level
+    void normalise(juce::AudioBuffer<float>& buffer)
+    {
+        float maxSumSquared = 0.0f;
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            auto* data = buffer.getReadPointer(ch);
+            float sum = 0.0f;
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                sum += data[i] * data[i];
+            maxSumSquared = std::max(maxSumSquared, sum);
+        }
+
+        if (maxSumSquared > 0.0f)
+            buffer.applyGain(1.0f / std::sqrt(maxSumSquared));
+    }
+}
+
+bool ImprintCache::setSource(const juce::AudioBuffer<float>& imprint, double sampleRate)
+{
+    auto trimmed = std::make_shared<const juce::AudioBuffer<float>>(trimSilence(imprint));
+    if (trimmed->getNumSamples() == 0)
+        return false;
+
+    const juce::ScopedLock sl(lock);
+    source = std::move(trimmed);
+    sourceRate = sampleRate;
+    ++generation;
+    resampled.clear();
+    prepared.clear();
+    return true;
+}
+
+bool ImprintCache::hasSource() const
+{
+    const juce::ScopedLock sl(lock);
+    return source != nullptr && source->getNumSamples() > 0;
+}
+
+std::shared_ptr<const PartitionedImprint> ImprintCache::getVariant(double sampleRate, int partitionSize)
+{
+    auto rate = juce::roundToInt(sampleRate);
+    auto key = std::make_pair(rate, partitionSize);
+
+    // Retry if setSource lands mid-build, so the result always matches the current source
+    for (;;)
+    {
+        Buffer sourceBuffer, resampledBuffer;
+        double rateOfSource = 0.0;
+        uint64_t buildGeneration = 0;
+
+        {
+            const juce::ScopedLock sl(lock);
+
+            if (source == nullptr || source->getNumSamples() == 0)
+                return nullptr;
+
+            if (auto it = prepared.find(key); it != prepared.end())
+                return it->second;
+
+            if (auto it = resampled.find(rate); it != resampled.end())
+                resampledBuffer = it->second;
+
+            sourceBuffer = source;
+            rateOfSource = sourceRate;
+            buildGeneration = generation;
+        }
+
+        if (resampledBuffer == nullptr)
+        {
+            auto variant = ImprintResampler(rateOfSource, sampleRate).process(*sourceBuffer);
+            normalise(variant);
+            resampledBuffer = std::make_shared<const juce::AudioBuffer<float>>(std::move(variant));
+        }
+
+        auto imprint = PartitionedImprint::create(*resampledBuffer, partitionSize);
+
+        const juce::ScopedLock sl(lock);
+
+        if (buildGeneration != generation)
+            continue;
+
+        resampled.emplace(rate, resampledBuffer);
+
+        // Another thread may have finished the same variant first; keep whichever is already shared
+        return prepared.emplace(key, imprint).first->second;
+    }
+}
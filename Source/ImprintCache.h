@@ -0,0 +1,36 @@
+#pragma once
+
+#include "PartitionedConvolver.h"
+
+#include <map>
+
+// Holds the loaded imprint plus every resampled / partitioned variant built from it,
+// so returning to a sample rate or block size that was seen before costs nothing.
+class ImprintCache
+{
+public:
+    ImprintCache() = default;
+
+    // Trims silence from both ends; previously prepared variants are discarded.
+    // Returns false, leaving the current source in place, if nothing audible is left.
+    bool setSource(const juce::AudioBuffer<float>& imprint, double sampleRate);
+    bool hasSource() const;
+
+    // Returns nullptr when no imprint is loaded. May resample and transform, so keep it off the audio thread;
+    // the lock is not held while building, so cached lookups never wait behind another build.
+    std::shared_ptr<const PartitionedImprint> getVariant(double sampleRate, int partitionSize);
+
+private:
+    using Buffer = std::shared_ptr<const juce::AudioBuffer<float>>;
+
+    // Guards the maps only; resampling and transforms run with it released
+    juce::CriticalSection lock;
+    Buffer source;
+    double sourceRate = 0.0;
+    uint64_t generation = 0;   // bumped by setSource so builds from an older source are dropped
+
+    std::map<int, Buffer> resampled;   // keyed by rate in Hz
+    std::map<std::pair<int, int>, std::shared_ptr<const PartitionedImprint>> prepared;   // rate, partition size
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ImprintCache)
+};
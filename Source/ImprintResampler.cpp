@@ -0,0 +1,136 @@
+#include "ImprintResampler.h"
+
+#include <numeric>
+
+namespace
+{
+    constexpr int maxPhases = 1024;
+    constexpr int zeroCrossings = 32;
+    constexpr double rolloff = 0.95;
+    constexpr double kaiserBeta = 9.0; // ~90 dB stopband
+
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; term > sum * 1.0e-12; ++k)
+        {
+            auto t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+        }
+        return sum;
+    }
+
+    double sinc(double x)
+    {
+        if (std::abs(x) < 1.0e-9)
+            return 1.0;
+
+        auto px = juce::MathConstants<double>::pi * x;
+        return std::sin(px) / px;
+    }
+}
+
+ImprintResampler::ImprintResampler(double sourceRate, double targetRate)
+{
+    auto source = std::max<int64_t>(1, static_cast<int64_t>(std::llround(sourceRate)));
+    auto target = std::max<int64_t>(1, static_cast<int64_t>(std::llround(targetRate)));
+    auto divisor = std::gcd(source, target);
+    upFactor = target / divisor;
+    downFactor = source / divisor;
+
+    if (isIdentity())
+        return;
+
+    // Rational ratios with few phases get an exact table; anything else interpolates between phases
+    numPhases = static_cast<int>(std::min<int64_t>(upFactor, maxPhases));
+
+    auto ratio = std::min(1.0, static_cast<double>(upFactor) / static_cast<double>(downFactor));
+    auto bandwidth = ratio * rolloff;
+    halfTaps = static_cast<int>(std::ceil(zeroCrossings / ratio));
+    numTaps = (2 * halfTaps + 3) & ~3;
+
+    coefficients.assign(static_cast<size_t>((numPhases + 1) * numTaps), 0.0f);
+    auto windowNorm = 1.0 / besselI0(kaiserBeta);
+    std::vector<double> taps(static_cast<size_t>(2 * halfTaps));
+
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        auto* row = coefficients.data() + phase * numTaps;
+        auto frac = static_cast<double>(phase) / numPhases;
+        double sum = 0.0;
+
+        for (int j = 0; j < 2 * halfTaps; ++j)
+        {
+            auto tau = frac + halfTaps - 1 - j;
+            auto x = tau / halfTaps;
+            auto window = std::abs(x) < 1.0 ? besselI0(kaiserBeta * std::sqrt(1.0 - x * x)) * windowNorm : 0.0;
+            taps[static_cast<size_t>(j)] = bandwidth * sinc(bandwidth * tau) * window;
+            sum += taps[static_cast<size_t>(j)];
+        }
+
+        // Unity DC gain for every phase
+        for (int j = 0; j < 2 * halfTaps; ++j)
+            row[j] = static_cast<float>(taps[static_cast<size_t>(j)] / sum);
+    }
+}
+
+float ImprintResampler::dotProduct(const float* samples, const float* taps) const
+{
+    // Four independent lanes so the loop maps onto SSE/NEON registers
+    float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for (int i = 0; i < numTaps; i += 4)
+        for (int lane = 0; lane < 4; ++lane)
+            lanes[lane] += samples[i + lane] * taps[i + lane];
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+juce::AudioBuffer<float> ImprintResampler::process(const juce::AudioBuffer<float>& source) const
+{
+    if (isIdentity())
+        return source;
+
+    auto inLength = static_cast<int64_t>(source.getNumSamples());
+    auto outLength = static_cast<int>((inLength * upFactor + downFactor - 1) / downFactor);
+
+    juce::AudioBuffer<float> result(source.getNumChannels(), outLength);
+
+    // Zero-padded copy of each channel so the filter never reads past either end
+    std::vector<float> padded(static_cast<size_t>(inLength + halfTaps + numTaps), 0.0f);
+    auto exactPhases = (numPhases == upFactor);
+
+    for (int ch = 0; ch < source.getNumChannels(); ++ch)
+    {
+        std::fill(padded.begin(), padded.end(), 0.0f);
+        std::copy(source.getReadPointer(ch), source.getReadPointer(ch) + inLength,
+                  padded.begin() + halfTaps);
+
+        auto* dest = result.getWritePointer(ch);
+
+        for (int n = 0; n < outLength; ++n)
+        {
+            auto position = static_cast<int64_t>(n) * downFactor;
+            auto base = position / upFactor;
+            auto phaseIndex = position % upFactor;
+            auto* window = padded.data() + base + 1;
+
+            if (exactPhases)
+            {
+                dest[n] = dotProduct(window, coefficients.data() + phaseIndex * numTaps);
+            }
+            else
+            {
+                auto phase = static_cast<double>(phaseIndex) * numPhases / static_cast<double>(upFactor);
+                auto lower = static_cast<int>(phase);
+                auto weight = static_cast<float>(phase - lower);
+                auto a = dotProduct(window, coefficients.data() + lower * numTaps);
+                auto b = dotProduct(window, coefficients.data() + (lower + 1) * numTaps);
+                dest[n] = a + (b - a) * weight;
+            }
+        }
+    }
+
+    return result;
+}
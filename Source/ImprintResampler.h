@@ -0,0 +1,24 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// Polyphase windowed-sinc sample rate converter for whole buffers (imprints and offline inputs).
+class ImprintResampler
+{
+public:
+    ImprintResampler(double sourceRate, double targetRate);
+
+    bool isIdentity() const { return upFactor == downFactor; }
+    juce::AudioBuffer<float> process(const juce::AudioBuffer<float>& source) const;
+
+private:
+    float dotProduct(const float* samples, const float* taps) const;
+
+    int64_t upFactor = 1, downFactor = 1;
+    int numPhases = 1;
+    int halfTaps = 0;
+    int numTaps = 0;   // padded to a multiple of four for the vectorised dot product
+    std::vector<float> coefficients;   // (numPhases + 1) rows of numTaps
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ImprintResampler)
+};
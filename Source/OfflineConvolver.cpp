@@ -1,4 +1,6 @@
 #include "OfflineConvolver.h"
+#include "ImprintResampler.h"
+#include "PartitionedConvolver.h"
 
 OfflineConvolver::OfflineConvolver()
     : juce::Thread("OfflineConvolver")
@@ -58,66 +60,60 @@ void OfflineConvolver::run()
 
     if (threadShouldExit()) return;
 
-    setStatusMessage("Convolving...");
-
-    // FFT-based convolution
-    int64_t convLen = lenA + lenB - 1;
-    int fftOrder = 0;
-    int64_t fftSize = 1;
-    while (fftSize < convLen)
+    // The output is written at Sample A's rate, so bring Sample B onto it first
+    ImprintResampler resamplerB(readerB->sampleRate, sampleRate);
+    if (! resamplerB.isIdentity())
     {
-        fftSize <<= 1;
-        fftOrder++;
+        setStatusMessage("Resampling Sample B...");
+        bufferB = resamplerB.process(bufferB);
+        lenB = bufferB.getNumSamples();
     }
 
-    juce::dsp::FFT fft(fftOrder);
-    auto fftDataSize = fftSize * 2; // complex pairs
+    if (threadShouldExit()) return;
 
-    juce::AudioBuffer<float> result(static_cast<int>(numChannels), static_cast<int>(convLen));
-    result.clear();
+    // Duplicate narrower inputs across every output channel
+    for (int ch = static_cast<int>(readerA->numChannels); ch < static_cast<int>(numChannels); ++ch)
+        bufferA.copyFrom(ch, 0, bufferA, static_cast<int>(readerA->numChannels) - 1, 0, static_cast<int>(lenA));
+    for (int ch = static_cast<int>(readerB->numChannels); ch < static_cast<int>(numChannels); ++ch)
+        bufferB.copyFrom(ch, 0, bufferB, static_cast<int>(readerB->numChannels) - 1, 0, static_cast<int>(lenB));
 
-    for (int ch = 0; ch < static_cast<int>(numChannels); ++ch)
-    {
-        if (threadShouldExit()) return;
+    int64_t convLen = lenA + lenB - 1;
 
-        std::vector<float> fftA(static_cast<size_t>(fftDataSize), 0.0f);
-        std::vector<float> fftB(static_cast<size_t>(fftDataSize), 0.0f);
+    // The default budget is a share of total RAM, not what is free right now, so at least
+    // take out the inputs and the result this job already holds
+    auto bufferBytes = static_cast<int64_t>(numChannels) * (lenA + lenB + convLen) * static_cast<int64_t>(sizeof(float));
+    auto memoryBudget = std::max<int64_t>(0, ConvolutionPlan::getDefaultMemoryBudget() - bufferBytes);
 
-        // Copy channel data (or duplicate mono to fill channels)
-        int chA = std::min(ch, static_cast<int>(readerA->numChannels) - 1);
-        int chB = std::min(ch, static_cast<int>(readerB->numChannels) - 1);
-        auto* srcA = bufferA.getReadPointer(chA);
-        auto* srcB = bufferB.getReadPointer(chB);
+    auto plan = ConvolutionPlan::choose(lenA, lenB, static_cast<int>(numChannels), memoryBudget);
+    setStatusMessage("Convolving (" + plan.describe() + ")...");
 
-        for (int64_t i = 0; i < lenA; ++i)
-            fftA[static_cast<size_t>(i)] = srcA[i];
-        for (int64_t i = 0; i < lenB; ++i)
-            fftB[static_cast<size_t>(i)] = srcB[i];
+    juce::AudioBuffer<float> result(static_cast<int>(numChannels), static_cast<int>(convLen));
+    result.clear();
 
-        // Forward FFT
-        fft.performRealOnlyForwardTransform(fftA.data());
-        fft.performRealOnlyForwardTransform(fftB.data());
+    // Convolution is commutative, so the shorter input is always treated as the filter
+    auto& signal = lenA >= lenB ? bufferA : bufferB;
+    auto& filter = lenA >= lenB ? bufferB : bufferA;
 
-        // Complex multiplication
-        for (int64_t i = 0; i < fftDataSize; i += 2)
-        {
-            float realA = fftA[static_cast<size_t>(i)];
-            float imagA = fftA[static_cast<size_t>(i + 1)];
-            float realB = fftB[static_cast<size_t>(i)];
-            float imagB = fftB[static_cast<size_t>(i + 1)];
+    auto startTime = juce::Time::getMillisecondCounterHiRes();
+    bool completed = false;
 
-            fftA[static_cast<size_t>(i)]     = realA * realB - imagA * imagB;
-            fftA[static_cast<size_t>(i + 1)] = realA * imagB + imagA * realB;
-        }
+    switch (plan.algorithm)
+    {
+        case ConvolutionPlan::Algorithm::Direct:      completed = convolveDirect(signal, filter, result); break;
+        case ConvolutionPlan::Algorithm::Partitioned: completed = convolvePartitioned(signal, filter, plan.partitionSize, result); break;
+        case ConvolutionPlan::Algorithm::SingleFFT:   completed = convolveSingleFFT(signal, filter, result); break;
+    }
 
-        // Inverse FFT
-        fft.performRealOnlyInverseTransform(fftA.data());
+    if (! completed) return;
 
-        // Copy result
-        auto* dest = result.getWritePointer(ch);
-        for (int64_t i = 0; i < convLen; ++i)
-            dest[i] = fftA[static_cast<size_t>(i)];
-    }
+    auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - startTime;
+    juce::Logger::writeToLog("OfflineConvolver: " + plan.describe()
+                             + " for " + juce::String(lenA) + " x " + juce::String(lenB)
+                             + " samples, " + juce::String(numChannels) + " ch; estimated "
+                             + juce::String(plan.estimatedOps / 1.0e6, 1) + " Mops / "
+                             + juce::String(static_cast<double>(plan.estimatedBytes) / (1024.0 * 1024.0), 1) + " MB, took "
+                             + juce::String(elapsedMs, 1) + " ms ("
+                             + juce::String(plan.estimatedOps / (juce::jmax(elapsedMs, 0.001) * 1.0e6), 2) + " Gops/s)");
 
     if (threadShouldExit()) return;
 
@@ -165,3 +161,130 @@ void OfflineConvolver::run()
     setStatusMessage("Done! Exported to: " + outputFile.getFileName());
     status.store(Status::Done);
 }
+
+bool OfflineConvolver::convolveDirect(const juce::AudioBuffer<float>& signal, const juce::AudioBuffer<float>& filter,
+                                      juce::AudioBuffer<float>& result)
+{
+    auto signalLen = signal.getNumSamples();
+    auto filterLen = filter.getNumSamples();
+    auto resultLen = result.getNumSamples();
+
+    for (int ch = 0; ch < result.getNumChannels(); ++ch)
+    {
+        auto* src = signal.getReadPointer(ch);
+        auto* taps = filter.getReadPointer(ch);
+        auto* dest = result.getWritePointer(ch);
+
+        // Every tap is applied to one cache-sized chunk of output before moving on,
+        // so the accumulator stays in L1 instead of streaming the whole result per tap
+        for (int start = 0; start < resultLen; start += directChunkSize)
+        {
+            if (threadShouldExit()) return false;
+
+            auto end = std::min(resultLen, start + directChunkSize);
+
+            for (int k = 0; k < filterLen; ++k)
+            {
+                auto from = std::max(start, k);
+                auto to = std::min(end, k + signalLen);
+
+                if (to > from)
+                    juce::FloatVectorOperations::addWithMultiply(dest + from, src + from - k, taps[k], to - from);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool OfflineConvolver::convolvePartitioned(const juce::AudioBuffer<float>& signal, const juce::AudioBuffer<float>& filter,
+                                           int partitionSize, juce::AudioBuffer<float>& result)
+{
+    PartitionedConvolver convolver;
+    convolver.prepare(PartitionedImprint::create(filter, partitionSize), result.getNumChannels());
+
+    juce::AudioBuffer<float> block(result.getNumChannels(), partitionSize);
+    auto signalLen = signal.getNumSamples();
+
+    // Feeding whole partitions makes the streaming engine a plain uniform-partitioned convolution
+    for (int start = 0; start < result.getNumSamples(); start += partitionSize)
+    {
+        if (threadShouldExit()) return false;
+
+        auto count = std::min(partitionSize, result.getNumSamples() - start);
+        auto available = juce::jlimit(0, count, signalLen - start);
+
+        block.clear();
+        for (int ch = 0; ch < result.getNumChannels(); ++ch)
+            if (available > 0)
+                block.copyFrom(ch, 0, signal, ch, start, available);
+
+        convolver.process(block, count);
+
+        for (int ch = 0; ch < result.getNumChannels(); ++ch)
+            result.copyFrom(ch, start, block, ch, 0, count);
+    }
+
+    return true;
+}
+
+bool OfflineConvolver::convolveSingleFFT(const juce::AudioBuffer<float>& signal, const juce::AudioBuffer<float>& filter,
+                                         juce::AudioBuffer<float>& result)
+{
+    auto lenA = static_cast<int64_t>(signal.getNumSamples());
+    auto lenB = static_cast<int64_t>(filter.getNumSamples());
+    auto convLen = static_cast<int64_t>(result.getNumSamples());
+
+    int fftOrder = 0;
+    int64_t fftSize = 1;
+    while (fftSize < convLen)
+    {
+        fftSize <<= 1;
+        fftOrder++;
+    }
+
+    juce::dsp::FFT fft(fftOrder);
+    auto fftDataSize = fftSize * 2; // complex pairs
+
+    for (int ch = 0; ch < result.getNumChannels(); ++ch)
+    {
+        if (threadShouldExit()) return false;
+
+        std::vector<float> fftA(static_cast<size_t>(fftDataSize), 0.0f);
+        std::vector<float> fftB(static_cast<size_t>(fftDataSize), 0.0f);
+
+        auto* srcA = signal.getReadPointer(ch);
+        auto* srcB = filter.getReadPointer(ch);
+
+        for (int64_t i = 0; i < lenA; ++i)
+            fftA[static_cast<size_t>(i)] = srcA[i];
+        for (int64_t i = 0; i < lenB; ++i)
+            fftB[static_cast<size_t>(i)] = srcB[i];
+
+        // Forward FFT
+        fft.performRealOnlyForwardTransform(fftA.data());
+        fft.performRealOnlyForwardTransform(fftB.data());
+
+        // Complex multiplication
+        for (int64_t i = 0; i < fftDataSize; i += 2)
+        {
+            float realA = fftA[static_cast<size_t>(i)];
+            float imagA = fftA[static_cast<size_t>(i + 1)];
+            float realB = fftB[static_cast<size_t>(i)];
+            float imagB = fftB[static_cast<size_t>(i + 1)];
+
+            fftA[static_cast<size_t>(i)]     = realA * realB - imagA * imagB;
+            fftA[static_cast<size_t>(i + 1)] = realA * imagB + imagA * realB;
+        }
+
+        // Inverse FFT
+        fft.performRealOnlyInverseTransform(fftA.data());
+
+        // Copy result
+        auto* dest = result.getWritePointer(ch);
+        for (int64_t i = 0; i < convLen; ++i)
+            dest[i] = fftA[static_cast<size_t>(i)];
+    }
+
+    return true;
+}
@@ -3,6 +3,8 @@
 #include <juce_audio_formats/juce_audio_formats.h>
 #include <juce_dsp/juce_dsp.h>
 
+#include "ConvolutionPlanner.h"
+
 class OfflineConvolver : public juce::Thread
 {
 public:
@@ -21,12 +23,22 @@ public:
     }
 
 private:
+    // Each returns false if the thread was asked to stop part-way through
+    bool convolveDirect(const juce::AudioBuffer<float>& signal, const juce::AudioBuffer<float>& filter,
+                        juce::AudioBuffer<float>& result);
+    bool convolvePartitioned(const juce::AudioBuffer<float>& signal, const juce::AudioBuffer<float>& filter,
+                             int partitionSize, juce::AudioBuffer<float>& result);
+    bool convolveSingleFFT(const juce::AudioBuffer<float>& signal, const juce::AudioBuffer<float>& filter,
+                           juce::AudioBuffer<float>& result);
+
     void setStatusMessage(const juce::String& msg)
     {
         const juce::ScopedLock sl(messageLock);
         statusMessage = msg;
     }
 
+    static constexpr int directChunkSize = 4096;   // output samples per pass of the direct loop, 16 KB per channel
+
     juce::File fileA, fileB, outputFile;
     std::atomic<Status> status { Status::Idle };
     juce::CriticalSection messageLock;
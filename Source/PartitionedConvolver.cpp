@@ -0,0 +1,319 @@
+#include "PartitionedConvolver.h"
+
+namespace
+{
+    // out += a * b over interleaved complex bins
+    void multiplyAccumulate(const float* a, const float* b, float* out, int numBins)
+    {
+        for (int i = 0; i < 2 * numBins; i += 2)
+        {
+            out[i]     += a[i] * b[i]     - a[i + 1] * b[i + 1];
+            out[i + 1] += a[i] * b[i + 1] + a[i + 1] * b[i];
+        }
+    }
+
+    // out -= a * b over interleaved complex bins
+    void multiplySubtract(const float* a, const float* b, float* out, int numBins)
+    {
+        for (int i = 0; i < 2 * numBins; i += 2)
+        {
+            out[i]     -= a[i] * b[i]     - a[i + 1] * b[i + 1];
+            out[i + 1] -= a[i] * b[i + 1] + a[i + 1] * b[i];
+        }
+    }
+
+    // Rebuild the negative frequencies the inverse transform expects from bins 0..fftSize/2
+    void mirrorNegativeFrequencies(float* data, int fftSize)
+    {
+        for (int i = 1; i < fftSize / 2; ++i)
+        {
+            data[2 * (fftSize - i)]     =  data[2 * i];
+            data[2 * (fftSize - i) + 1] = -data[2 * i + 1];
+        }
+    }
+}
+
+std::shared_ptr<const PartitionedImprint> PartitionedImprint::create(const juce::AudioBuffer<float>& imprint, int partitionSize)
+{
+    jassert(juce::isPowerOfTwo(partitionSize));
+
+    auto result = std::make_shared<PartitionedImprint>();
+    result->setSize(partitionSize, std::max(1, (imprint.getNumSamples() + partitionSize - 1) / partitionSize),
+                    imprint.getNumChannels());
+
+    juce::dsp::FFT fft(getFftOrder(partitionSize));
+    std::vector<float> fftBuffer(static_cast<size_t>(4 * partitionSize));
+
+    for (int ch = 0; ch < result->numChannels; ++ch)
+    {
+        for (int p = 0; p < result->numPartitions; ++p)
+        {
+            auto start = p * partitionSize;
+            result->setPartition(ch, p, imprint.getReadPointer(ch) + start,
+                                 std::min(partitionSize, imprint.getNumSamples() - start), fft, fftBuffer.data());
+        }
+    }
+
+    return result;
+}
+
+int PartitionedImprint::getFftOrder(int partitionSize)
+{
+    return juce::roundToInt(std::log2(static_cast<double>(partitionSize))) + 1;
+}
+
+void PartitionedImprint::setSize(int newPartitionSize, int newNumPartitions, int newNumChannels)
+{
+    partitionSize = newPartitionSize;
+    numPartitions = newNumPartitions;
+    numChannels = newNumChannels;
+    spectra.assign(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(numPartitions * getStride()), 0.0f));
+}
+
+void PartitionedImprint::setPartition(int channel, int partition, const float* samples, int numSamples,
+                                      const juce::dsp::FFT& fft, float* fftBuffer)
+{
+    jassert(numSamples <= partitionSize);
+
+    auto count = juce::jmax(0, numSamples);
+    juce::FloatVectorOperations::copy(fftBuffer, samples, count);
+    juce::FloatVectorOperations::clear(fftBuffer + count, 4 * partitionSize - count);
+
+    fft.performRealOnlyForwardTransform(fftBuffer, true);
+    juce::FloatVectorOperations::copy(spectra[static_cast<size_t>(channel)].data() + partition * getStride(),
+                                      fftBuffer, getStride());
+}
+
+void PartitionedConvolver::prepare(std::shared_ptr<const PartitionedImprint> newImprint, int numChannels)
+{
+    imprint = std::move(newImprint);
+    jassert(imprint != nullptr);
+
+    allocate(imprint->partitionSize, imprint->numPartitions, numChannels);
+}
+
+void PartitionedConvolver::prepare(int newPartitionSize, int maxPartitions, int numChannels)
+{
+    imprint.reset();
+    allocate(newPartitionSize, maxPartitions, numChannels);
+}
+
+void PartitionedConvolver::allocate(int newPartitionSize, int maxPartitions, int numChannels)
+{
+    jassert(juce::isPowerOfTwo(newPartitionSize) && maxPartitions > 0);
+
+    partitionSize = newPartitionSize;
+    numSegments = maxPartitions;
+
+    auto stride = static_cast<size_t>(2 * (partitionSize + 1));
+
+    fft = std::make_unique<juce::dsp::FFT>(PartitionedImprint::getFftOrder(partitionSize));
+    fftBuffer.assign(static_cast<size_t>(4 * partitionSize), 0.0f);
+    fadeBuffer.assign(static_cast<size_t>(4 * partitionSize), 0.0f);
+
+    channels.resize(static_cast<size_t>(numChannels));
+    for (auto& state : channels)
+    {
+        state.input.assign(static_cast<size_t>(partitionSize), 0.0f);
+        state.segments.assign(stride * static_cast<size_t>(numSegments), 0.0f);
+        state.history.assign(stride, 0.0f);
+        state.previousHistory.assign(stride, 0.0f);
+        state.overlap.assign(static_cast<size_t>(partitionSize), 0.0f);
+        state.lastSum.assign(stride, 0.0f);
+        state.fadeOverlap.assign(static_cast<size_t>(partitionSize), 0.0f);
+    }
+
+    reset();
+}
+
+void PartitionedConvolver::reset()
+{
+    for (auto& state : channels)
+    {
+        std::fill(state.input.begin(), state.input.end(), 0.0f);
+        std::fill(state.segments.begin(), state.segments.end(), 0.0f);
+        std::fill(state.history.begin(), state.history.end(), 0.0f);
+        std::fill(state.previousHistory.begin(), state.previousHistory.end(), 0.0f);
+        std::fill(state.overlap.begin(), state.overlap.end(), 0.0f);
+        std::fill(state.lastSum.begin(), state.lastSum.end(), 0.0f);
+        std::fill(state.fadeOverlap.begin(), state.fadeOverlap.end(), 0.0f);
+        state.position = 0;
+        state.segment = 0;
+        state.fading = false;
+    }
+}
+
+void PartitionedConvolver::process(juce::AudioBuffer<float>& buffer, int numSamples)
+{
+    jassert(imprint != nullptr);
+
+    process(buffer, 0, numSamples, { imprint.get(), nullptr, imprint->numPartitions }, nullptr);
+}
+
+void PartitionedConvolver::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                   const PartitionMap& map, const PartitionMap* previousMap)
+{
+    jassert(map.imprint != nullptr && map.imprint->partitionSize == partitionSize);
+    jassert(map.numPartitions <= numSegments && (previousMap == nullptr || previousMap->numPartitions <= numSegments));
+
+    auto numChannels = std::min(buffer.getNumChannels(), static_cast<int>(channels.size()));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        processChannel(channels[static_cast<size_t>(ch)],
+                       std::min(ch, map.imprint->numChannels - 1),
+                       buffer.getWritePointer(ch, startSample), numSamples, map, previousMap);
+}
+
+const float* PartitionedConvolver::getSegment(const ChannelState& state, int blocksBack) const
+{
+    auto segment = (state.segment + 2 * numSegments - blocksBack) % numSegments;
+    return state.segments.data() + segment * 2 * (partitionSize + 1);
+}
+
+void PartitionedConvolver::accumulate(const ChannelState& state, int imprintChannel, const PartitionMap& map,
+                                      int firstPartition, int blocksBack, float* out) const
+{
+    juce::FloatVectorOperations::clear(out, 2 * (partitionSize + 1));
+
+    for (int p = firstPartition; p < map.numPartitions; ++p)
+        multiplyAccumulate(getSegment(state, p + blocksBack), map.get(imprintChannel, p), out, partitionSize + 1);
+}
+
+void PartitionedConvolver::sumBlock(const ChannelState& state, const std::vector<float>& history, int imprintChannel,
+                                    const PartitionMap& map, float* work) const
+{
+    juce::FloatVectorOperations::copy(work, history.data(), 2 * (partitionSize + 1));
+    if (map.numPartitions > 0)
+        multiplyAccumulate(getSegment(state, 0), map.get(imprintChannel, 0), work, partitionSize + 1);
+}
+
+void PartitionedConvolver::prepareFade(ChannelState& state, int imprintChannel,
+                                       const PartitionMap& map, const PartitionMap& previousMap)
+{
+    auto stride = 2 * (partitionSize + 1);
+    auto numBins = partitionSize + 1;
+    auto numPositions = std::max(map.numPartitions, previousMap.numPartitions);
+    auto* tail = fadeBuffer.data();
+
+    int numChanged = 0;
+    for (int p = 0; p < numPositions; ++p)
+        if (map.getSlot(p) != previousMap.getSlot(p))
+            ++numChanged;
+
+    // Both the previous map's history and the tail the current map would have left from the previous block
+    // differ from sums already at hand only at the positions that changed, which for a snapshot filling in
+    // is a single partition. Past half the positions, summing both from scratch is cheaper.
+    if (2 * numChanged < numPositions)
+    {
+        juce::FloatVectorOperations::copy(state.previousHistory.data(), state.history.data(), stride);
+        juce::FloatVectorOperations::copy(tail, state.lastSum.data(), stride);
+
+        for (int p = 0; p < numPositions; ++p)
+        {
+            if (map.getSlot(p) == previousMap.getSlot(p))
+                continue;
+
+            if (p < map.numPartitions)
+            {
+                if (p > 0)
+                    multiplySubtract(getSegment(state, p), map.get(imprintChannel, p), state.previousHistory.data(), numBins);
+
+                multiplyAccumulate(getSegment(state, p + 1), map.get(imprintChannel, p), tail, numBins);
+            }
+
+            if (p < previousMap.numPartitions)
+            {
+                if (p > 0)
+                    multiplyAccumulate(getSegment(state, p), previousMap.get(imprintChannel, p), state.previousHistory.data(), numBins);
+
+                multiplySubtract(getSegment(state, p + 1), previousMap.get(imprintChannel, p), tail, numBins);
+            }
+        }
+    }
+    else
+    {
+        accumulate(state, imprintChannel, previousMap, 1, 0, state.previousHistory.data());
+        accumulate(state, imprintChannel, map, 0, 1, tail);
+    }
+
+    mirrorNegativeFrequencies(tail, 2 * partitionSize);
+    fft->performRealOnlyInverseTransform(tail);
+    juce::FloatVectorOperations::copy(state.fadeOverlap.data(), tail + partitionSize, partitionSize);
+}
+
+void PartitionedConvolver::processChannel(ChannelState& state, int imprintChannel, float* data, int numSamples,
+                                          const PartitionMap& map, const PartitionMap* previousMap)
+{
+    auto fftSize = 2 * partitionSize;
+    auto stride = 2 * (partitionSize + 1);
+    auto* work = fftBuffer.data();
+
+    int done = 0;
+    while (done < numSamples)
+    {
+        auto count = std::min(numSamples - done, partitionSize - state.position);
+        juce::FloatVectorOperations::copy(state.input.data() + state.position, data + done, count);
+
+        // Older partitions only change once per block, so their sum is computed when a block starts.
+        // The current segment slot still holds the oldest input here, which a fade's tail needs.
+        if (state.position == 0)
+        {
+            state.fading = previousMap != nullptr;
+            accumulate(state, imprintChannel, map, 1, 0, state.history.data());
+
+            if (state.fading)
+                prepareFade(state, imprintChannel, map, *previousMap);
+        }
+
+        // The current, partially filled partition is re-transformed on every call for zero latency
+        juce::FloatVectorOperations::copy(work, state.input.data(), partitionSize);
+        juce::FloatVectorOperations::clear(work + partitionSize, 2 * fftSize - partitionSize);
+        fft->performRealOnlyForwardTransform(work, true);
+        juce::FloatVectorOperations::copy(state.segments.data() + state.segment * stride, work, stride);
+
+        sumBlock(state, state.history, imprintChannel, map, work);
+
+        // Kept for the next block, in case that one fades to a new map
+        if (state.position + count == partitionSize)
+            juce::FloatVectorOperations::copy(state.lastSum.data(), work, stride);
+
+        mirrorNegativeFrequencies(work, fftSize);
+        fft->performRealOnlyInverseTransform(work);
+
+        if (state.fading)
+        {
+            // Ramp across the block from the previous map's output to the current map's, each at its own gain
+            auto* old = fadeBuffer.data();
+            sumBlock(state, state.previousHistory, imprintChannel, *previousMap, old);
+            mirrorNegativeFrequencies(old, fftSize);
+            fft->performRealOnlyInverseTransform(old);
+
+            for (int i = 0; i < count; ++i)
+            {
+                auto n = state.position + i;
+                auto ramp = static_cast<float>(n) / static_cast<float>(partitionSize);
+                auto from = previousMap->gain * (old[n] + state.overlap[static_cast<size_t>(n)]);
+                auto to = map.gain * (work[n] + state.fadeOverlap[static_cast<size_t>(n)]);
+                data[done + i] = from + ramp * (to - from);
+            }
+        }
+        else
+        {
+            juce::FloatVectorOperations::add(data + done, work + state.position, state.overlap.data() + state.position, count);
+
+            if (! juce::exactlyEqual(map.gain, 1.0f))
+                juce::FloatVectorOperations::multiply(data + done, map.gain, count);
+        }
+
+        state.position += count;
+        done += count;
+
+        if (state.position == partitionSize)
+        {
+            juce::FloatVectorOperations::copy(state.overlap.data(), work + partitionSize, partitionSize);
+            juce::FloatVectorOperations::clear(state.input.data(), partitionSize);
+            state.position = 0;
+            state.segment = (state.segment + 1) % numSegments;
+        }
+    }
+}
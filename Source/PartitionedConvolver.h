@@ -0,0 +1,109 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+
+// Frequency-domain partitions of an imprint, prepared once for a given sample rate and partition size.
+struct PartitionedImprint
+{
+    static std::shared_ptr<const PartitionedImprint> create(const juce::AudioBuffer<float>& imprint, int partitionSize);
+
+    // Transforms use twice the partition size, so the product of two partitions doesn't wrap
+    static int getFftOrder(int partitionSize);
+
+    // Zero-filled storage for numPartitions partitions per channel
+    void setSize(int newPartitionSize, int newNumPartitions, int newNumChannels);
+
+    // Transforms up to partitionSize samples into one partition; fftBuffer must hold 4 * partitionSize floats.
+    void setPartition(int channel, int partition, const float* samples, int numSamples,
+                      const juce::dsp::FFT& fft, float* fftBuffer);
+
+    int getStride() const { return 2 * (partitionSize + 1); }   // interleaved complex bins 0..partitionSize
+    const float* getPartition(int channel, int partition) const
+    {
+        return spectra[static_cast<size_t>(channel)].data() + partition * getStride();
+    }
+
+    int partitionSize = 0;
+    int numPartitions = 0;
+    int numChannels = 0;
+    std::vector<std::vector<float>> spectra;
+};
+
+// Which stored partition plays at each position of the imprint; slots == nullptr plays them in order.
+// Live captures use this to reorder partitions without touching the spectra.
+struct PartitionMap
+{
+    int getSlot(int partition) const
+    {
+        if (partition >= numPartitions)
+            return -1;
+
+        return slots != nullptr ? slots[partition] : partition;
+    }
+
+    const float* get(int channel, int partition) const { return imprint->getPartition(channel, getSlot(partition)); }
+
+    const PartitionedImprint* imprint = nullptr;
+    const int* slots = nullptr;
+    int numPartitions = 0;
+    float gain = 1.0f;   // applied to the output, so a live capture can be normalised without rescaling its spectra
+};
+
+// Zero-latency uniformly partitioned convolution. Mono imprints are applied to every channel.
+class PartitionedConvolver
+{
+public:
+    PartitionedConvolver() = default;
+
+    // Allocates all streaming state; call off the audio thread.
+    void prepare(std::shared_ptr<const PartitionedImprint> imprint, int numChannels);
+
+    // For imprints supplied per call through a PartitionMap of up to maxPartitions partitions.
+    void prepare(int partitionSize, int maxPartitions, int numChannels);
+    void reset();
+
+    // Convolves the first numSamples of each channel in place with the prepared imprint. Real-time safe.
+    void process(juce::AudioBuffer<float>& buffer, int numSamples);
+
+    // Convolves with the given map. If previousMap is set when a block starts, that block crossfades
+    // from the previous map to the current one, so the map may change on any block boundary without a click.
+    // previousMap must be the map the previous block was convolved with.
+    void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                 const PartitionMap& map, const PartitionMap* previousMap);
+
+private:
+    struct ChannelState
+    {
+        std::vector<float> input;             // current partition, filled as samples arrive
+        std::vector<float> segments;          // ring of spectra of recent input partitions
+        std::vector<float> history;           // older partitions' contribution to the current block
+        std::vector<float> previousHistory;   // the same under the previous map, while fading
+        std::vector<float> overlap;           // second half of the previous block's result
+        std::vector<float> lastSum;           // spectrum of the previous block's result
+        std::vector<float> fadeOverlap;       // the same under the current map, while fading
+        int position = 0;
+        int segment = 0;
+        bool fading = false;
+    };
+
+    void allocate(int partitionSize, int maxPartitions, int numChannels);
+    void processChannel(ChannelState& state, int imprintChannel, float* data, int numSamples,
+                        const PartitionMap& map, const PartitionMap* previousMap);
+    const float* getSegment(const ChannelState& state, int blocksBack) const;
+
+    // Sums partition p against the input segment p + blocksBack blocks old, for every p from firstPartition on
+    void accumulate(const ChannelState& state, int imprintChannel, const PartitionMap& map,
+                    int firstPartition, int blocksBack, float* out) const;
+    void sumBlock(const ChannelState& state, const std::vector<float>& history, int imprintChannel,
+                  const PartitionMap& map, float* work) const;
+    void prepareFade(ChannelState& state, int imprintChannel, const PartitionMap& map, const PartitionMap& previousMap);
+
+    std::shared_ptr<const PartitionedImprint> imprint;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<ChannelState> channels;
+    std::vector<float> fftBuffer, fadeBuffer;
+    int partitionSize = 0;
+    int numSegments = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolver)
+};
@@ -20,10 +20,7 @@ ConvolutionPluginEditor::ConvolutionPluginEditor(ConvolutionPluginProcessor& p)
                 {
                     auto file = fc.getResult();
                     if (file.existsAsFile())
-                    {
                         processorRef.loadImpulseResponse(file);
-                        imprintFileLabel.setText(file.getFileName(), juce::dontSendNotification);
-                    }
                 });
         };
 
@@ -32,6 +29,9 @@ ConvolutionPluginEditor::ConvolutionPluginEditor(ConvolutionPluginProcessor& p)
         auto imprintName = processorRef.getIRFileName();
         imprintFileLabel.setText(imprintName.isNotEmpty() ? imprintName : "No imprint loaded", juce::dontSendNotification);
 
+        // Imprints load in the background and silent files are rejected, so follow the processor
+        startTimerHz(4);
+
         addAndMakeVisible(dryWetSlider);
         dryWetSlider.setSliderStyle(juce::Slider::LinearHorizontal);
         dryWetSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
@@ -48,7 +48,25 @@ ConvolutionPluginEditor::ConvolutionPluginEditor(ConvolutionPluginProcessor& p)
 
         addAndMakeVisible(gainLabel);
 
-        setSize(500, 200);
+        addAndMakeVisible(imprintSourceBox);
+        imprintSourceBox.addItemList({ "File", "Sidechain Snapshot", "Sidechain Rolling" }, 1);
+        imprintSourceAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+            processorRef.apvts, "imprintsource", imprintSourceBox);
+
+        addAndMakeVisible(imprintSourceLabel);
+
+        addAndMakeVisible(captureButton);
+        captureButton.onClick = [this] { processorRef.captureSidechainSnapshot(); };
+
+        addAndMakeVisible(captureLengthSlider);
+        captureLengthSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+        captureLengthSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
+        captureLengthAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+            processorRef.apvts, "capturelength", captureLengthSlider);
+
+        addAndMakeVisible(captureLengthLabel);
+
+        setSize(500, 280);
     }
     else
     {
@@ -143,6 +161,8 @@ ConvolutionPluginEditor::~ConvolutionPluginEditor()
     stopTimer();
     dryWetAttachment.reset();
     gainAttachment.reset();
+    imprintSourceAttachment.reset();
+    captureLengthAttachment.reset();
 }
 
 bool ConvolutionPluginEditor::isStandalone() const
@@ -189,6 +209,20 @@ void ConvolutionPluginEditor::resized()
         auto gainRow = area.removeFromTop(30);
         gainLabel.setBounds(gainRow.removeFromLeft(80));
         gainSlider.setBounds(gainRow);
+
+        area.removeFromTop(10);
+
+        auto sourceRow = area.removeFromTop(30);
+        imprintSourceLabel.setBounds(sourceRow.removeFromLeft(80));
+        captureButton.setBounds(sourceRow.removeFromRight(90));
+        sourceRow.removeFromRight(10);
+        imprintSourceBox.setBounds(sourceRow);
+
+        area.removeFromTop(10);
+
+        auto lengthRow = area.removeFromTop(30);
+        captureLengthLabel.setBounds(lengthRow.removeFromLeft(80));
+        captureLengthSlider.setBounds(lengthRow);
     }
     else
     {
@@ -259,7 +293,6 @@ void ConvolutionPluginEditor::filesDropped(const juce::StringArray& files, int,
         if (file.existsAsFile() && (ext == ".wav" || ext == ".aif" || ext == ".aiff" || ext == ".flac"))
         {
             processorRef.loadImpulseResponse(file);
-            imprintFileLabel.setText(file.getFileName(), juce::dontSendNotification);
             break;
         }
     }
@@ -275,4 +308,13 @@ void ConvolutionPluginEditor::timerCallback()
         if (status == OfflineConvolver::Status::Done || status == OfflineConvolver::Status::Error)
             stopTimer();
     }
+    else
+    {
+        auto imprintName = processorRef.getIRFileName();
+        if (imprintName.isEmpty())
+            imprintName = "No imprint loaded";
+
+        if (imprintName != imprintFileLabel.getText())
+            imprintFileLabel.setText(imprintName, juce::dontSendNotification);
+    }
 }
@@ -35,9 +35,16 @@ private:
     juce::Slider gainSlider;
     juce::Label dryWetLabel { {}, "Dry/Wet" };
     juce::Label gainLabel { {}, "Gain (dB)" };
+    juce::ComboBox imprintSourceBox;
+    juce::TextButton captureButton { "Capture" };
+    juce::Slider captureLengthSlider;
+    juce::Label imprintSourceLabel { {}, "Source" };
+    juce::Label captureLengthLabel { {}, "Length (s)" };
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> dryWetAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> imprintSourceAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> captureLengthAttachment;
 
     // Standalone mode: offline convolution controls
     juce::TextButton loadSampleAButton { "Load Sample A" };
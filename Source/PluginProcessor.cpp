@@ -4,12 +4,17 @@
 ConvolutionPluginProcessor::ConvolutionPluginProcessor()
     : AudioProcessor(BusesProperties()
                          .withInput("Input", juce::AudioChannelSet::stereo(), true)
+                         .withInput("Sidechain", juce::AudioChannelSet::stereo(), false)
                          .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
       apvts(*this, nullptr, "Parameters", createParameterLayout())
 {
 }
 
-ConvolutionPluginProcessor::~ConvolutionPluginProcessor() {}
+ConvolutionPluginProcessor::~ConvolutionPluginProcessor()
+{
+    // Jobs touch most members, so none may outlive them
+    imprintPool.removeAllJobs(true, 10000);
+}
 
 juce::AudioProcessorValueTreeState::ParameterLayout ConvolutionPluginProcessor::createParameterLayout()
 {
@@ -23,18 +28,97 @@ juce::AudioProcessorValueTreeState::ParameterLayout ConvolutionPluginProcessor::
         juce::ParameterID{"gain", 1}, "Output Gain",
         juce::NormalisableRange<float>(-24.0f, 12.0f, 0.1f), 0.0f, "dB"));
 
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{"imprintsource", 1}, "Imprint Source",
+        juce::StringArray{"File", "Sidechain Snapshot", "Sidechain Rolling"}, 0));
+
+    params.push_back(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{"capturelength", 1}, "Capture Length",
+        juce::NormalisableRange<float>(0.05f, maxCaptureSeconds, 0.01f), 0.5f, "s"));
+
     return { params.begin(), params.end() };
 }
 
 void ConvolutionPluginProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = static_cast<juce::uint32>(samplesPerBlock);
-    spec.numChannels = static_cast<juce::uint32>(getTotalNumOutputChannels());
+    auto numChannels = getTotalNumOutputChannels();
+
+    auto partitionSize = juce::jlimit(128, 4096, juce::nextPowerOfTwo(samplesPerBlock));
+
+    {
+        // Load jobs still building for the old spec see the change and drop their engines
+        const juce::SpinLock::ScopedLockType lock(convolverLock);
+        currentSampleRate = sampleRate;
+        currentPartitionSize = partitionSize;
+        pendingConvolver.reset();
+        pendingConvolverIsNew = false;
+    }
+
+    // Cached variants make this cheap when the host returns to a rate or block size it used before
+    activeConvolver = createConvolver(sampleRate, partitionSize);
+
+    // The live imprint is allocated for the longest capture so length changes never allocate
+    auto maxCapturePartitions = static_cast<int>(std::ceil(maxCaptureSeconds * sampleRate / partitionSize));
+    auto rollingHop = std::max(1, juce::roundToInt(rollingStepSeconds * sampleRate / partitionSize));
+    sidechainCapture.prepare(partitionSize, maxCapturePartitions, 2, rollingHop);
+    liveConvolver.prepare(partitionSize, maxCapturePartitions, numChannels);
+    liveWasActive = false;
+
+    dryBuffer.setSize(numChannels, samplesPerBlock);
+    fadeBuffer.setSize(numChannels, samplesPerBlock);
+
+    prewarmImprintVariants();
+}
+
+std::unique_ptr<PartitionedConvolver> ConvolutionPluginProcessor::createConvolver(double sampleRate, int partitionSize)
+{
+    if (sampleRate <= 0.0)
+        return nullptr;
+
+    auto imprint = imprintCache.getVariant(sampleRate, partitionSize);
+    if (imprint == nullptr)
+        return nullptr;
 
-    convolution.prepare(spec);
-    dryBuffer.setSize(static_cast<int>(spec.numChannels), samplesPerBlock);
+    auto convolver = std::make_unique<PartitionedConvolver>();
+    convolver->prepare(std::move(imprint), getTotalNumOutputChannels());
+    return convolver;
+}
+
+void ConvolutionPluginProcessor::installConvolver(std::unique_ptr<PartitionedConvolver> newConvolver,
+                                                  double sampleRate, int partitionSize)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(convolverLock);
+
+        // Built for a spec prepareToPlay has since replaced; it already made its own engine
+        if (! juce::exactlyEqual(sampleRate, currentSampleRate) || partitionSize != currentPartitionSize)
+            return;
+
+        std::swap(pendingConvolver, newConvolver);
+        pendingConvolverIsNew = true;
+    }
+
+    // newConvolver now holds whatever was pending and is released here, off the audio thread
+}
+
+void ConvolutionPluginProcessor::prewarmImprintVariants()
+{
+    int partitionSize;
+    {
+        const juce::SpinLock::ScopedLockType lock(convolverLock);
+        partitionSize = currentPartitionSize;
+    }
+
+    if (! imprintCache.hasSource() || partitionSize == 0)
+        return;
+
+    // Build the common rates in the background so later rate switches hit the cache.
+    // Queued loads must not be removed here; a stale prewarm only finds cache hits.
+    imprintPool.addJob([this, partitionSize]
+    {
+        for (auto rate : { 44100.0, 48000.0, 96000.0 })
+            imprintCache.getVariant(rate, partitionSize);
+    });
 }
 
 void ConvolutionPluginProcessor::releaseResources() {}
@@ -48,6 +132,12 @@ bool ConvolutionPluginProcessor::isBusesLayoutSupported(const BusesLayout& layou
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
 
+    auto sidechain = layouts.getChannelSet(true, 1);
+    if (! sidechain.isDisabled()
+        && sidechain != juce::AudioChannelSet::mono()
+        && sidechain != juce::AudioChannelSet::stereo())
+        return false;
+
     return true;
 }
 
@@ -55,8 +145,8 @@ void ConvolutionPluginProcessor::processBlock(juce::AudioBuffer<float>& buffer,
 {
     juce::ScopedNoDenormals noDenormals;
 
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    auto totalNumInputChannels = getMainBusNumInputChannels();
+    auto totalNumOutputChannels = getMainBusNumOutputChannels();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
@@ -64,48 +154,177 @@ void ConvolutionPluginProcessor::processBlock(juce::AudioBuffer<float>& buffer,
     float dryWet = apvts.getRawParameterValue("drywet")->load();
     float gainDb = apvts.getRawParameterValue("gain")->load();
     float gainLinear = juce::Decibels::decibelsToGain(gainDb);
+    auto source = juce::roundToInt(apvts.getRawParameterValue("imprintsource")->load());
+    auto liveActive = source != 0;
+    auto snapshot = snapshotRequested.exchange(false);
+
+    if (liveActive)
+        updateSidechainCapture(source == 2, snapshot);
+
+    // The host buffer also carries the sidechain channels; everything below works on the main bus
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
+    auto sidechainBuffer = getBusCount(true) > 1 && getChannelCountOfBus(true, 1) > 0
+                               ? getBusBuffer(buffer, true, 1) : juce::AudioBuffer<float>();
+    auto* sidechain = sidechainBuffer.getNumChannels() > 0 ? &sidechainBuffer : nullptr;
 
     // Keep a copy of the dry signal (pre-allocated buffer, no heap allocation)
-    auto numSamples = buffer.getNumSamples();
-    auto numChannels = buffer.getNumChannels();
+    auto numSamples = mainBuffer.getNumSamples();
+    auto numChannels = mainBuffer.getNumChannels();
 
     jassert(dryBuffer.getNumChannels() >= numChannels && dryBuffer.getNumSamples() >= numSamples);
 
     for (int ch = 0; ch < numChannels; ++ch)
-        dryBuffer.copyFrom(ch, 0, buffer, ch, 0, numSamples);
+        dryBuffer.copyFrom(ch, 0, mainBuffer, ch, 0, numSamples);
 
     // Process wet signal through convolution
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-    convolution.process(context);
+    {
+        const juce::SpinLock::ScopedTryLockType lock(convolverLock);
+
+        // Engine heard in the previous block; stays valid while the lock keeps pendingConvolver untouched
+        auto* previous = liveWasActive ? &liveConvolver : activeConvolver.get();
+
+        if (lock.isLocked() && pendingConvolverIsNew)
+        {
+            std::swap(activeConvolver, pendingConvolver);
+            pendingConvolverIsNew = false;
+        }
+
+        auto* current = liveActive ? &liveConvolver : activeConvolver.get();
+
+        if (current == previous)
+        {
+            processWet(current, mainBuffer, numSamples, sidechain);
+        }
+        else
+        {
+            // An engine that sat idle still holds old input history
+            if (current != nullptr)
+                current->reset();
+
+            // The capture then counts partition boundaries from the same sample as the reset engine
+            if (current == &liveConvolver)
+                sidechainCapture.reset();
+
+            // Crossfade from the outgoing imprint (or the unprocessed input) to the new one
+            for (int ch = 0; ch < numChannels; ++ch)
+                fadeBuffer.copyFrom(ch, 0, mainBuffer, ch, 0, numSamples);
+
+            processWet(previous, fadeBuffer, numSamples, sidechain);
+            processWet(current, mainBuffer, numSamples, sidechain);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                mainBuffer.applyGainRamp(ch, 0, numSamples, 0.0f, 1.0f);
+                mainBuffer.addFromWithRamp(ch, 0, fadeBuffer.getReadPointer(ch), numSamples, 1.0f, 0.0f);
+            }
+        }
+
+        liveWasActive = liveActive;
+    }
 
     // Mix dry and wet
-    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    for (int ch = 0; ch < numChannels; ++ch)
     {
-        auto* wet = buffer.getWritePointer(ch);
+        auto* wet = mainBuffer.getWritePointer(ch);
         auto* dry = dryBuffer.getReadPointer(ch);
 
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        for (int i = 0; i < numSamples; ++i)
             wet[i] = (dry[i] * (1.0f - dryWet) + wet[i] * dryWet) * gainLinear;
     }
 }
 
-void ConvolutionPluginProcessor::loadImpulseResponse(const juce::File& file)
+void ConvolutionPluginProcessor::processWet(PartitionedConvolver* engine, juce::AudioBuffer<float>& target, int numSamples,
+                                            const juce::AudioBuffer<float>* sidechain)
 {
-    if (file.existsAsFile())
+    if (engine == nullptr)
+        return;
+
+    if (engine != &liveConvolver)
+    {
+        engine->process(target, numSamples);
+        return;
+    }
+
+    // The captured imprint and its normalisation only change on partition boundaries, so each run stops at one;
+    // the convolver then crossfades the following block from the old imprint and gain to the new ones
+    for (int done = 0; done < numSamples;)
     {
-        irFilePath = file.getFullPathName();
-        convolution.loadImpulseResponse(file,
-                                        juce::dsp::Convolution::Stereo::yes,
-                                        juce::dsp::Convolution::Trim::yes,
-                                        0);
+        auto count = std::min(numSamples - done, sidechainCapture.getSamplesToBoundary());
+
+        liveConvolver.process(target, done, count, sidechainCapture.getMap(), sidechainCapture.getPreviousMap());
+        sidechainCapture.push(sidechain, done, count);
+        done += count;
     }
 }
 
+void ConvolutionPluginProcessor::updateSidechainCapture(bool rolling, bool startSnapshot)
+{
+    auto lengthSeconds = apvts.getRawParameterValue("capturelength")->load();
+    sidechainCapture.setLength(static_cast<int>(std::ceil(lengthSeconds * currentSampleRate / currentPartitionSize)));
+    sidechainCapture.setRolling(rolling);
+
+    if (startSnapshot && ! rolling)
+        sidechainCapture.startSnapshot();
+}
+
+void ConvolutionPluginProcessor::loadImpulseResponse(const juce::File& file)
+{
+    if (! file.existsAsFile())
+        return;
+
+    // Decoding, resampling and transforming a long imprint takes a while, so keep it off the caller's thread
+    imprintPool.addJob([this, file]
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr)
+            return;
+
+        auto numChannels = static_cast<int>(std::min(reader->numChannels, 2u));
+        auto length = static_cast<int>(reader->lengthInSamples);
+
+        juce::AudioBuffer<float> imprint(numChannels, length);
+        reader->read(&imprint, 0, length, 0, true, numChannels > 1);
+
+        // Silent or empty files are rejected, leaving the current imprint playing
+        if (! imprintCache.setSource(imprint, reader->sampleRate))
+            return;
+
+        {
+            const juce::ScopedLock sl(irFilePathLock);
+            irFilePath = file.getFullPathName();
+        }
+
+        double sampleRate;
+        int partitionSize;
+        {
+            const juce::SpinLock::ScopedLockType lock(convolverLock);
+            sampleRate = currentSampleRate;
+            partitionSize = currentPartitionSize;
+        }
+
+        if (auto convolver = createConvolver(sampleRate, partitionSize))
+            installConvolver(std::move(convolver), sampleRate, partitionSize);
+
+        prewarmImprintVariants();
+    });
+}
+
+juce::String ConvolutionPluginProcessor::getIRFileName() const
+{
+    const juce::ScopedLock sl(irFilePathLock);
+    return irFilePath.isNotEmpty() ? juce::File(irFilePath).getFileName() : juce::String();
+}
+
 void ConvolutionPluginProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     auto state = apvts.copyState();
-    state.setProperty("irFilePath", irFilePath, nullptr);
+    {
+        const juce::ScopedLock sl(irFilePathLock);
+        state.setProperty("irFilePath", irFilePath, nullptr);
+    }
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
 }
@@ -3,6 +3,9 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
 
+#include "ImprintCache.h"
+#include "SidechainCapture.h"
+
 class ConvolutionPluginProcessor : public juce::AudioProcessor
 {
 public:
@@ -35,16 +38,46 @@ public:
     void setStateInformation(const void* data, int sizeInBytes) override;
 
     void loadImpulseResponse(const juce::File& file);
-    juce::String getIRFileName() const { return irFilePath.isNotEmpty() ? juce::File(irFilePath).getFileName() : juce::String(); }
+
+    // Starts a fresh capture in Sidechain Snapshot mode; ignored in the other imprint sources.
+    void captureSidechainSnapshot() { snapshotRequested.store(true); }
+    juce::String getIRFileName() const;
 
     juce::AudioProcessorValueTreeState apvts;
 
 private:
+    static constexpr float maxCaptureSeconds = 2.0f;
+    static constexpr float rollingStepSeconds = 0.02f;   // how often a full rolling window moves on
+
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
-    juce::dsp::Convolution convolution;
-    juce::AudioBuffer<float> dryBuffer;
+    std::unique_ptr<PartitionedConvolver> createConvolver(double sampleRate, int partitionSize);
+    void installConvolver(std::unique_ptr<PartitionedConvolver> newConvolver, double sampleRate, int partitionSize);
+    void prewarmImprintVariants();
+    void processWet(PartitionedConvolver* engine, juce::AudioBuffer<float>& target, int numSamples,
+                    const juce::AudioBuffer<float>* sidechain);
+    void updateSidechainCapture(bool rolling, bool startSnapshot);
+
+    ImprintCache imprintCache;
+    juce::ThreadPool imprintPool { 1 };   // imprint loads and prewarming; drained in the destructor
+
+    // The audio thread owns activeConvolver; replacements arrive through pendingConvolver,
+    // which afterwards holds the outgoing engine so it is freed off the audio thread.
+    std::unique_ptr<PartitionedConvolver> activeConvolver, pendingConvolver;
+    bool pendingConvolverIsNew = false;
+    juce::SpinLock convolverLock;   // also guards currentSampleRate / currentPartitionSize writes
+
+    // Sidechain imprint: captured and convolved entirely on the audio thread
+    SidechainCapture sidechainCapture;
+    PartitionedConvolver liveConvolver;
+    std::atomic<bool> snapshotRequested { false };
+    bool liveWasActive = false;
+
+    juce::AudioBuffer<float> dryBuffer, fadeBuffer;
     juce::String irFilePath;
+    juce::CriticalSection irFilePathLock;   // set by the load job, read by the editor and state saving
+    double currentSampleRate = 0.0;
+    int currentPartitionSize = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionPluginProcessor)
 };
@@ -0,0 +1,238 @@
+#include "SidechainCapture.h"
+
+void SidechainCapture::prepare(int partitionSize, int maxPartitions, int numChannels, int newRollingHop)
+{
+    jassert(juce::isPowerOfTwo(partitionSize) && maxPartitions > 0 && newRollingHop > 0);
+
+    // A full imprint, a hop of pending partitions including the one a commit writes into, and the silent slot
+    rollingHop = newRollingHop;
+    auto numSlots = maxPartitions + rollingHop + 1;
+    storage.setSize(partitionSize, numSlots, numChannels);
+    zeroSlot = numSlots - 1;
+
+    fft = std::make_unique<juce::dsp::FFT>(PartitionedImprint::getFftOrder(partitionSize));
+    fftBuffer.assign(static_cast<size_t>(4 * partitionSize), 0.0f);
+    partition.setSize(numChannels, partitionSize);
+    partition.clear();
+
+    slots.assign(static_cast<size_t>(maxPartitions), zeroSlot);
+    previousSlots.assign(static_cast<size_t>(maxPartitions), zeroSlot);
+    retiredSlots.clear();
+    retiredSlots.reserve(static_cast<size_t>(numSlots));
+    pendingSlots.clear();
+    pendingSlots.reserve(static_cast<size_t>(rollingHop));
+    freeSlots.clear();
+    freeSlots.reserve(static_cast<size_t>(numSlots));
+    for (int slot = zeroSlot - 1; slot >= 0; --slot)
+        freeSlots.push_back(slot);
+
+    previousMap = { &storage, previousSlots.data(), 0, 1.0f };
+
+    slotEnergy.assign(static_cast<size_t>(numChannels * numSlots), 0.0);
+
+    // Empty until the first length arrives, which then starts recording
+    numActive = 0;
+    requestedLength = 0;
+    numFilled = 0;
+    capturing = false;
+    reset();
+}
+
+void SidechainCapture::reset()
+{
+    // Nothing reads the previous map after a reset, so pending changes can apply straight away
+    releaseRetiredSlots();
+    if (requestedLength != numActive)
+        applyLength();
+
+    releaseRetiredSlots();
+    updateGain();
+
+    hasPrevious = false;
+    position = 0;
+    partitionComplete = true;
+}
+
+void SidechainCapture::setLength(int numPartitions)
+{
+    requestedLength = juce::jlimit(1, static_cast<int>(slots.size()), numPartitions);
+}
+
+void SidechainCapture::startSnapshot()
+{
+    // Overwrite from the start, so the previous snapshot morphs into the new one partition by partition
+    numFilled = 0;
+    capturing = true;
+}
+
+void SidechainCapture::push(const juce::AudioBuffer<float>* sidechain, int startSample, int numSamples)
+{
+    auto partitionSize = partition.getNumSamples();
+    int done = 0;
+
+    while (done < numSamples)
+    {
+        auto count = std::min(numSamples - done, partitionSize - position);
+
+        // Always recorded, so a snapshot requested mid-partition still commits a whole partition
+        if (sidechain != nullptr && sidechain->getNumChannels() > 0)
+        {
+            for (int ch = 0; ch < partition.getNumChannels(); ++ch)
+                partition.copyFrom(ch, position, *sidechain, std::min(ch, sidechain->getNumChannels() - 1),
+                                   startSample + done, count);
+        }
+        else
+        {
+            partitionComplete = false;
+        }
+
+        position += count;
+        done += count;
+
+        if (position == partitionSize)
+            finishPartition();
+    }
+}
+
+void SidechainCapture::finishPartition()
+{
+    // The block that just ended was the last to read the slots retired before it
+    releaseRetiredSlots();
+
+    std::copy(slots.begin(), slots.begin() + numActive, previousSlots.begin());
+    previousMap.numPartitions = numActive;
+    previousMap.gain = gain;
+
+    auto changed = requestedLength != numActive;
+    if (changed)
+        applyLength();
+
+    // Steps gathered while rolling would be out of date by the time rolling resumes
+    if (! rolling)
+        discardPendingSlots();
+
+    if (partitionComplete && numActive > 0 && (rolling || (capturing && numFilled < numActive)))
+        changed = commitPartition() || changed;
+
+    if (! rolling && numFilled == numActive)
+        capturing = false;
+
+    if (changed)
+        updateGain();
+
+    hasPrevious = changed;
+    position = 0;
+    partitionComplete = true;
+}
+
+bool SidechainCapture::commitPartition()
+{
+    jassert(! freeSlots.empty());
+
+    auto slot = freeSlots.back();
+    freeSlots.pop_back();
+
+    auto partitionSize = partition.getNumSamples();
+
+    for (int ch = 0; ch < storage.numChannels; ++ch)
+    {
+        auto* src = partition.getReadPointer(ch);
+
+        double energy = 0.0;
+        for (int i = 0; i < partitionSize; ++i)
+            energy += static_cast<double>(src[i]) * src[i];
+
+        slotEnergy[static_cast<size_t>(ch * storage.numPartitions + slot)] = energy;
+        storage.setPartition(ch, slot, src, partitionSize, *fft, fftBuffer.data());
+    }
+
+    if (numFilled < numActive)
+    {
+        retire(slots[static_cast<size_t>(numFilled)]);
+        slots[static_cast<size_t>(numFilled++)] = slot;
+        return true;
+    }
+
+    // Full rolling window: once a hop is recorded the oldest partitions drop out and the new ones become the last
+    pendingSlots.push_back(slot);
+    if (static_cast<int>(pendingSlots.size()) < rollingHop)
+        return false;
+
+    auto numPending = static_cast<int>(pendingSlots.size());
+    auto numNew = std::min(numPending, numActive);
+
+    for (int i = 0; i < numPending - numNew; ++i)
+        retire(pendingSlots[static_cast<size_t>(i)]);
+    for (int i = 0; i < numNew; ++i)
+        retire(slots[static_cast<size_t>(i)]);
+
+    std::move(slots.begin() + numNew, slots.begin() + numActive, slots.begin());
+    std::copy(pendingSlots.end() - numNew, pendingSlots.end(), slots.begin() + (numActive - numNew));
+    pendingSlots.clear();
+    return true;
+}
+
+void SidechainCapture::applyLength()
+{
+    auto newLength = requestedLength;
+
+    if (newLength > numActive)
+    {
+        // New partitions are recorded from here on, so anything older still pending would land after them
+        discardPendingSlots();
+        std::fill(slots.begin() + numActive, slots.begin() + newLength, zeroSlot);
+        capturing = true;
+    }
+    else
+    {
+        // A rolling window keeps its newest partitions, a snapshot its first ones
+        auto drop = rolling ? std::max(0, numFilled - newLength) : 0;
+
+        for (int i = 0; i < drop; ++i)
+            retire(slots[static_cast<size_t>(i)]);
+        for (int i = drop + newLength; i < numActive; ++i)
+            retire(slots[static_cast<size_t>(i)]);
+
+        std::move(slots.begin() + drop, slots.begin() + drop + newLength, slots.begin());
+        numFilled = std::min(numFilled - drop, newLength);
+    }
+
+    numActive = newLength;
+}
+
+void SidechainCapture::retire(int slot)
+{
+    if (slot != zeroSlot)
+        retiredSlots.push_back(slot);
+}
+
+void SidechainCapture::releaseRetiredSlots()
+{
+    freeSlots.insert(freeSlots.end(), retiredSlots.begin(), retiredSlots.end());
+    retiredSlots.clear();
+}
+
+void SidechainCapture::discardPendingSlots()
+{
+    for (auto slot : pendingSlots)
+        retire(slot);
+
+    pendingSlots.clear();
+}
+
+void SidechainCapture::updateGain()
+{
+    double maxEnergy = 0.0;
+    for (int ch = 0; ch < storage.numChannels; ++ch)
+    {
+        double energy = 0.0;
+        for (int i = 0; i < numActive; ++i)
+            energy += slotEnergy[static_cast<size_t>(ch * storage.numPartitions + slots[static_cast<size_t>(i)])];
+
+        maxEnergy = std::max(maxEnergy, energy);
+    }
+
+    // Nothing recorded plays nothing at any gain, so unity keeps the first real partition from fading in from +60 dB.
+    // Otherwise capped at +60 dB so a near-silent sidechain doesn't blow up the noise floor.
+    gain = maxEnergy > 0.0 ? static_cast<float>(1.0 / std::sqrt(std::max(maxEnergy, 1.0e-6))) : 1.0f;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "PartitionedConvolver.h"
+
+// Records the sidechain into a live imprint, transforming one partition each time one fills.
+// Partitions are stored in slots that a PartitionMap orders, so a new partition, a rolling step or a
+// length change only rewrites the map, and only on partition boundaries shared with the live convolver.
+// Everything but prepare() runs on the audio thread.
+class SidechainCapture
+{
+public:
+    SidechainCapture() = default;
+
+    // Allocates room for maxPartitions; call off the audio thread. A full rolling window steps
+    // rollingHop partitions at a time, since every step crossfades the whole imprint.
+    void prepare(int partitionSize, int maxPartitions, int numChannels, int rollingHop);
+
+    // Starts partition timing afresh, for when the live convolver has just been reset. Captured partitions are kept.
+    void reset();
+
+    // Takes effect on the next partition boundary. Shrinking drops partitions, growing records only the new ones.
+    void setLength(int numPartitions);
+
+    // Rolling keeps replacing the oldest partition; otherwise capture stops once the imprint is full.
+    void setRolling(bool shouldRoll) { rolling = shouldRoll; }
+    void startSnapshot();
+
+    // Pushes never need to cross a boundary, but may. The sidechain may be nullptr when there is none,
+    // which keeps the timing but leaves the current partition unrecorded.
+    int getSamplesToBoundary() const { return partition.getNumSamples() - position; }
+    void push(const juce::AudioBuffer<float>* sidechain, int startSample, int numSamples);
+
+    // The imprint as it stands, and, for the block after a boundary that changed it, the imprint before.
+    // Each carries the gain that brings it to unit energy, like a loaded file.
+    PartitionMap getMap() const { return { &storage, slots.data(), numActive, gain }; }
+    const PartitionMap* getPreviousMap() const { return hasPrevious ? &previousMap : nullptr; }
+
+private:
+    void finishPartition();
+    bool commitPartition();
+    void applyLength();
+    void retire(int slot);
+    void releaseRetiredSlots();
+    void discardPendingSlots();
+    void updateGain();
+
+    PartitionedImprint storage;
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::vector<float> fftBuffer;
+    juce::AudioBuffer<float> partition;   // samples of the partition currently being recorded
+
+    // Slot tables and free lists are sized in prepare() so the audio thread never allocates.
+    // Slots replaced at a boundary stay retired for one block, while the crossfade still reads them.
+    // Rolling steps wait in pendingSlots until a whole hop has been recorded.
+    std::vector<int> slots, previousSlots, freeSlots, retiredSlots, pendingSlots;
+    PartitionMap previousMap;
+    int zeroSlot = 0;   // never written, stands in for partitions not recorded yet
+
+    std::vector<double> slotEnergy;   // per channel, per slot
+    float gain = 1.0f;
+    int rollingHop = 1;
+    int numActive = 0;
+    int requestedLength = 0;
+    int position = 0;
+    int numFilled = 0;
+    bool capturing = false;
+    bool rolling = false;
+    bool hasPrevious = false;
+    bool partitionComplete = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SidechainCapture)
+};